@@ -14,6 +14,7 @@
 #include <sys/stat.h>
 #include <time.h>
 #include <ctype.h>
+#include <fcntl.h>
 
 #define PORT 8080
 #define SERVER_IP "127.0.0.1"
@@ -22,6 +23,9 @@
 #define MAX_QUEUE 10
 #define MAX_INPUT 256
 #define MAX_HISTORY 5
+#define UI_REFRESH_MS 250 // redraw interval; progress is interpolated between STATUS pushes
+#define BATCH_TIMEOUT 5 // seconds without an OK/ERR reply, while commands are pending, before batch mode gives up
+#define BATCH_MAX_PENDING (64 * 1024) // unsent bytes before batch mode stops reading input
 
 // ─────────────────────────────────────────────
 // Global State
@@ -106,8 +110,22 @@ void attach_response_to_last_command(const char *resp) {
 }
 
 // ─────────────────────────────────────────────
-// Utility: Time Formatter
+// Utility: Clock and Time Formatter
 // ─────────────────────────────────────────────
+double monotonic_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Advance the last reported position by the local time since it arrived
+double interpolate_elapsed(const char *state, double elapsed, double duration, double received_at) {
+    if (strcmp(state, "PLAYING") != 0) return elapsed;
+    elapsed += monotonic_seconds() - received_at;
+    if (duration > 0 && elapsed > duration) elapsed = duration;
+    return elapsed;
+}
+
 void print_time_mmss(double secs, char *out, size_t cap) {
     int s = (int)secs;
     if (s < 0) s = 0;
@@ -184,14 +202,244 @@ void disable_raw_mode(const struct termios *orig) {
     tcsetattr(STDIN_FILENO, TCSANOW, orig);
 }
 
+// ─────────────────────────────────────────────
+// Connection
+// ─────────────────────────────────────────────
+int connect_to_server() {
+    struct sockaddr_in server;
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) { perror("socket"); return -1; }
+
+    server.sin_family = AF_INET;
+    server.sin_port = htons(PORT);
+    server.sin_addr.s_addr = inet_addr(SERVER_IP);
+
+    if (connect(sock, (struct sockaddr *)&server, sizeof(server)) < 0) {
+        perror("connect");
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// ─────────────────────────────────────────────
+// Batch Mode
+// ─────────────────────────────────────────────
+// Commands sent but not yet answered, oldest first
+char **batch_cmds = NULL;
+int batch_head = 0, batch_len = 0, batch_cap = 0;
+int batch_closed = 0; // "exit"/"stop" queued: the server closes after it
+
+// Bytes queued for the server, of which batch_sent are already written
+char *batch_out = NULL;
+size_t batch_out_len = 0, batch_sent = 0, batch_out_cap = 0;
+
+// Queue one command for sending; blank lines and '#' comments are skipped.
+// Returns 0 once "exit"/"stop" is queued; later commands are ignored.
+int batch_add(const char *cmd) {
+    if (batch_closed) return 0;
+    while (isspace((unsigned char)*cmd)) cmd++;
+    size_t len = strcspn(cmd, "\r\n");
+    if (len == 0 || cmd[0] == '#') return 1;
+
+    if (batch_len == batch_cap) {
+        // drop answered entries before growing
+        if (batch_head > 0) {
+            memmove(batch_cmds, batch_cmds + batch_head, (batch_len - batch_head) * sizeof(char *));
+            batch_len -= batch_head;
+            batch_head = 0;
+        }
+        if (batch_len == batch_cap) {
+            batch_cap = batch_cap ? batch_cap * 2 : 64;
+            char **grown = realloc(batch_cmds, batch_cap * sizeof(char *));
+            if (!grown) { perror("realloc"); exit(2); }
+            batch_cmds = grown;
+        }
+    }
+    batch_cmds[batch_len] = strndup(cmd, len);
+    if (!batch_cmds[batch_len]) { perror("strndup"); exit(2); }
+    batch_len++;
+
+    if (batch_out_len + len + 1 > batch_out_cap) {
+        // drop sent bytes before growing
+        memmove(batch_out, batch_out + batch_sent, batch_out_len - batch_sent);
+        batch_out_len -= batch_sent;
+        batch_sent = 0;
+        while (batch_out_len + len + 1 > batch_out_cap) {
+            batch_out_cap = batch_out_cap ? batch_out_cap * 2 : BUF_SIZE;
+            char *grown = realloc(batch_out, batch_out_cap);
+            if (!grown) { perror("realloc"); exit(2); }
+            batch_out = grown;
+        }
+    }
+    memcpy(batch_out + batch_out_len, cmd, len);
+    batch_out[batch_out_len + len] = '\n';
+    batch_out_len += len + 1;
+
+    if (strncmp(cmd, "exit", 4) == 0 || strncmp(cmd, "stop", 4) == 0) batch_closed = 1;
+    return !batch_closed;
+}
+
+// Pipeline the queued commands plus any read from in_fd (-1 for none) as they arrive,
+// and match the OK/ERR replies back in order.
+// Returns 0 if all commands succeeded, 1 if any got ERR, 2 on connection errors.
+int run_batch(int sock, int in_fd) {
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+    char recvbuf[BUF_SIZE], inbuf[BUF_SIZE];
+    size_t recv_len = 0, in_len = 0;
+    int in_open = in_fd >= 0, in_discarding = 0, status = 0;
+    double waiting_since = monotonic_seconds(); // last reply, or when the queue was last empty
+
+    // Keep reading while sending so neither side stalls on a full socket buffer
+    while ((in_open && !batch_closed) || batch_head < batch_len) {
+        int maxfd = sock;
+        fd_set readfds, writefds;
+        FD_ZERO(&readfds);
+        FD_ZERO(&writefds);
+        FD_SET(sock, &readfds);
+        if (batch_sent < batch_out_len) FD_SET(sock, &writefds);
+        // stop reading input while the server is far behind, so memory stays bounded
+        if (in_open && !batch_closed && batch_out_len - batch_sent < BATCH_MAX_PENDING) {
+            FD_SET(in_fd, &readfds);
+            if (in_fd > maxfd) maxfd = in_fd;
+        }
+        // The server's periodic pushes keep the socket busy, so time replies, not traffic
+        if (batch_head == batch_len) waiting_since = monotonic_seconds();
+        double left = BATCH_TIMEOUT - (monotonic_seconds() - waiting_since);
+        if (left <= 0) {
+            fprintf(stderr, "Timed out waiting for response to '%s'\n", batch_cmds[batch_head]);
+            status = 2;
+            break;
+        }
+        struct timeval tv = {(time_t)left, (suseconds_t)((left - (time_t)left) * 1e6)};
+
+        int rv = select(maxfd + 1, &readfds, &writefds, NULL, &tv);
+        if (rv < 0) {
+            if (errno == EINTR) continue;
+            perror("select");
+            status = 2;
+            break;
+        }
+        if (rv == 0) continue;
+
+        if (in_open && FD_ISSET(in_fd, &readfds)) {
+            ssize_t n = read(in_fd, inbuf + in_len, sizeof(inbuf) - 1 - in_len);
+            if (n < 0 && errno != EINTR && errno != EAGAIN) {
+                perror("read");
+                in_open = 0;
+                status = 2;
+            } else if (n == 0) {
+                in_open = 0;
+                inbuf[in_len] = '\0';
+                if (!in_discarding) batch_add(inbuf); // last line without a newline
+            } else if (n > 0) {
+                in_len += n;
+                inbuf[in_len] = '\0';
+                char *line = inbuf, *nl;
+                while ((nl = strchr(line, '\n')) != NULL) {
+                    *nl = '\0';
+                    if (!in_discarding) batch_add(line);
+                    in_discarding = 0;
+                    line = nl + 1;
+                }
+                if (line == inbuf && in_len == sizeof(inbuf) - 1) {
+                    fprintf(stderr, "Skipping input line longer than %d bytes\n", BUF_SIZE - 1);
+                    in_discarding = 1;
+                    status = status ? status : 1;
+                    line = inbuf + in_len;
+                }
+                in_len -= line - inbuf;
+                memmove(inbuf, line, in_len);
+            }
+        }
+
+        if (FD_ISSET(sock, &writefds)) {
+            ssize_t n = send(sock, batch_out + batch_sent, batch_out_len - batch_sent, 0);
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                perror("send");
+                status = 2;
+                break;
+            }
+            if (n > 0) batch_sent += n;
+        }
+
+        if (FD_ISSET(sock, &readfds)) {
+            ssize_t n = recv(sock, recvbuf + recv_len, sizeof(recvbuf) - 1 - recv_len, 0);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) continue;
+            if (n <= 0) {
+                fprintf(stderr, "Server closed connection with %d commands unanswered\n", batch_len - batch_head);
+                status = 2;
+                break;
+            }
+            recv_len += n;
+            recvbuf[recv_len] = '\0';
+
+            char *line = recvbuf, *nl;
+            while ((nl = strchr(line, '\n')) != NULL) {
+                *nl = '\0';
+                // Skip the periodic pushes; everything else belongs to the oldest pending command
+                if (strncmp(line, "STATUS ", 7) == 0 || strncmp(line, "PLAYING ", 8) == 0 ||
+                    strncmp(line, "NEXT ", 5) == 0 || strncmp(line, "QUEUE ", 6) == 0 ||
+                    strncmp(line, "STOPPED", 7) == 0 || batch_head == batch_len) {
+                    // not a reply
+                } else if (strncmp(line, "OK", 2) == 0 || strncmp(line, "ERR", 3) == 0) {
+                    printf("%s\t%s\n", batch_cmds[batch_head], line);
+                    waiting_since = monotonic_seconds();
+                    if (line[0] == 'E') status = status ? status : 1;
+                    free(batch_cmds[batch_head++]);
+                } else {
+                    printf("%s\n", line); // body line, e.g. from "list"
+                }
+                line = nl + 1;
+            }
+            recv_len -= line - recvbuf;
+            memmove(recvbuf, line, recv_len);
+        }
+    }
+
+    fflush(stdout);
+    return status;
+}
+
 // ─────────────────────────────────────────────
 // Main
 // ─────────────────────────────────────────────
-int main() {
+int main(int argc, char *argv[]) {
     int sock;
-    struct sockaddr_in server;
     char recvbuf[BUF_SIZE];
 
+    // Batch mode: client -b [command ...] [-f file|-]; reads stdin if neither is given.
+    // File and stdin commands are streamed to the server as they are read.
+    if (argc > 1 && (strcmp(argv[1], "-b") == 0 || strcmp(argv[1], "--batch") == 0)) {
+        const char *path = NULL;
+        int more = 1;
+        for (int i = 2; i < argc; ++i) {
+            if (strcmp(argv[i], "-f") == 0) {
+                if (i + 2 != argc) {
+                    fprintf(stderr, "Usage: %s -b [command ...] [-f file|-]\n", argv[0]);
+                    return 2;
+                }
+                path = argv[++i];
+            } else if (more) {
+                more = batch_add(argv[i]);
+            }
+        }
+        int in_fd = -1;
+        if (more && (path || batch_len == 0)) {
+            in_fd = (!path || strcmp(path, "-") == 0) ? STDIN_FILENO : open(path, O_RDONLY);
+            if (in_fd < 0) { perror(path); return 2; }
+        }
+        if (batch_len == 0 && in_fd < 0) return 0;
+
+        sock = connect_to_server();
+        if (sock < 0) return 2;
+        setvbuf(stdout, NULL, _IOLBF, 0); // replies to streamed input show up as they arrive
+        int status = run_batch(sock, in_fd);
+        close(sock);
+        return status;
+    }
+
     mkdir("logs", 0755);
 
     time_t now = time(NULL);
@@ -207,17 +455,8 @@ int main() {
         fclose(session_log);
     }
 
-    sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) { perror("socket"); exit(1); }
-
-    server.sin_family = AF_INET;
-    server.sin_port = htons(PORT);
-    server.sin_addr.s_addr = inet_addr(SERVER_IP);
-
-    if (connect(sock, (struct sockaddr *)&server, sizeof(server)) < 0) {
-        perror("connect");
-        exit(1);
-    }
+    sock = connect_to_server();
+    if (sock < 0) exit(1);
 
     add_log("Connected to server.");
 
@@ -226,6 +465,7 @@ int main() {
 
     char current_state[32] = "STOPPED";
     double elapsed = 0.0, duration = 0.0;
+    double status_received_at = monotonic_seconds();
     char input_buffer[MAX_INPUT] = {0};
     int input_len = 0;
 
@@ -238,7 +478,7 @@ int main() {
         FD_ZERO(&readfds);
         FD_SET(STDIN_FILENO, &readfds);
         FD_SET(sock, &readfds);
-        struct timeval tv = {1, 0};
+        struct timeval tv = {0, UI_REFRESH_MS * 1000};
 
         int rv = select(maxfd + 1, &readfds, NULL, NULL, &tv);
         if (rv < 0) {
@@ -260,6 +500,7 @@ int main() {
             while (line) {
                 if (strncmp(line, "STATUS ", 7) == 0) {
                     sscanf(line + 7, "%31s %lf %lf", current_state, &elapsed, &duration);
+                    status_received_at = monotonic_seconds();
                 } else if (strncmp(line, "QUEUE ", 6) == 0) {
                     update_queue(line);
                 } else if (strncmp(line, "PLAYING ", 8) == 0) {
@@ -336,7 +577,9 @@ int main() {
             }
         }
 
-        draw_ui(current_state, elapsed, duration, input_buffer);
+        draw_ui(current_state,
+                interpolate_elapsed(current_state, elapsed, duration, status_received_at),
+                duration, input_buffer);
     }
 
 done:
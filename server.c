@@ -22,6 +22,13 @@
 #define MAX_SONGS 100
 #define MAX_LEN 512
 #define BACKLOG 5
+#define MAX_CLIENTS 32
+#define SNAPSHOT_FILE "playback.state"
+#define SNAPSHOT_INTERVAL 5       // seconds between periodic snapshots
+#define SPAWN_TARGET_MS 100.0     // warn if startup-to-player-spawn exceeds this on restore
+#define END_GRACE 2.0             // seconds past the probed duration before a player we cannot wait for is assumed done
+#define PREFETCH_LEAD 10.0        // seconds before track end to read ahead the next file
+#define DEFAULT_FRAMES_PER_SEC (44100.0 / 1152.0) // MPEG-1 Layer III @ 44.1 kHz, if probing fails
 
 /* Playlist */
 char *playlist[MAX_SONGS];
@@ -31,12 +38,43 @@ int song_count = 0;
 pid_t player_pid = -1;
 int current_song = -1;
 enum { STATE_STOPPED=0, STATE_PLAYING=1, STATE_PAUSED=2 } state = STATE_STOPPED;
+int owns_player = 0;          // this process started (or inherited) the player; only it writes snapshots
 
-/* Time accounting */
-time_t play_start = 0;        // wall time when playback started (or resumed)
-time_t paused_since = 0;      // when pause started
+/* Time accounting (CLOCK_MONOTONIC nanoseconds, immune to wall-clock jumps) */
+long long play_start = 0;     // when playback started
+long long paused_since = 0;   // when pause started, 0 if not paused
 double paused_accum = 0.0;    // total paused seconds accumulated during current song
 double current_duration = 0.0; // seconds (from ffprobe)
+double start_offset = 0.0;    // seconds skipped at launch (resume from snapshot)
+double current_fps = DEFAULT_FRAMES_PER_SEC; // MPEG frames per second, for mpg123 -k
+
+/* Read-ahead of the upcoming track */
+int prefetch_index = -1;        // song whose file was prefetched, -1 if none
+
+/* Monotonic clock in nanoseconds */
+long long monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Milliseconds elapsed since a monotonic_ns() timestamp */
+double ms_since(long long since) {
+    return (monotonic_ns() - since) / 1e6;
+}
+
+/* Shutdown flag, set from SIGINT/SIGTERM */
+volatile sig_atomic_t shutting_down = 0;
+
+void on_shutdown_signal(int sig) {
+    (void)sig;
+    shutting_down = 1;
+}
+
+/* No-op SIGCHLD handler: its only job is to interrupt select() when the player exits */
+void on_child_exit(int sig) {
+    (void)sig;
+}
 
 /* playlist persistence */
 void load_playlist() {
@@ -58,24 +96,62 @@ void save_playlist() {
     fclose(fp);
 }
 
-/* Utility: get duration (seconds) using ffprobe */
-double get_duration_seconds(const char *path) {
+/* Utility: get duration (seconds) using ffprobe; the same call also reads the sample
+   rate so *frames_per_sec can be derived (MP3 frames hold 1152 samples, 576 below 32 kHz) */
+double get_duration_seconds(const char *path, double *frames_per_sec) {
     char cmd[MAX_LEN*2];
     snprintf(cmd, sizeof(cmd),
-        "ffprobe -v error -show_entries format=duration -of default=noprint_wrappers=1:nokey=1 \"%s\" 2>/dev/null",
+        "ffprobe -v error -select_streams a:0 -show_entries stream=sample_rate:format=duration -of default=noprint_wrappers=1 \"%s\" 2>/dev/null",
         path);
+    *frames_per_sec = DEFAULT_FRAMES_PER_SEC;
     FILE *fp = popen(cmd, "r");
     if (!fp) return 0.0;
-    double dur = 0.0;
-    if (fscanf(fp, "%lf", &dur) != 1) {
-        dur = 0.0;
+    double dur = 0.0, rate = 0.0;
+    char line[128];
+    while (fgets(line, sizeof(line), fp)) {
+        sscanf(line, "duration=%lf", &dur);
+        sscanf(line, "sample_rate=%lf", &rate);
     }
     pclose(fp);
+    if (rate > 0) *frames_per_sec = rate / (rate >= 32000 ? 1152.0 : 576.0);
     return dur;
 }
 
-/* Start playback: kills existing player, reset time accounting, launches mpg123 */
-void play_song(int index) {
+/* Index of the song after the current one (wraps), -1 if the playlist is empty */
+int next_index() {
+    if (song_count == 0) return -1;
+    return (current_song + 1) % song_count;
+}
+
+/* Ask the kernel to pull the file into page cache in the background, so the
+   transition does not stall on cold storage; never blocks on the file's contents */
+void prefetch_song(int index) {
+    if (index < 0 || index >= song_count) return;
+    long long t0 = monotonic_ns();
+
+    int fd = open(playlist[index], O_RDONLY);
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        close(fd);
+    }
+    prefetch_index = index;
+    fprintf(stderr, "[server] Prefetch issued for '%s' in %.1f ms\n", playlist[index], ms_since(t0));
+}
+
+/* Forget the playback state without touching the player process */
+void reset_playback_state() {
+    player_pid = -1;
+    state = STATE_STOPPED;
+    current_song = -1;
+    paused_since = 0;
+    paused_accum = 0.0;
+    current_duration = 0.0;
+    start_offset = 0.0;
+}
+
+/* Start playback at an offset: kills existing player, reset time accounting, launches mpg123.
+   A known_duration > 0 (with its known_fps) skips the ffprobe call (used when restoring a snapshot). */
+void play_song_at(int index, double offset, double known_duration, double known_fps) {
     if (index < 0 || index >= song_count) return;
 
     // Kill existing player if any
@@ -88,31 +164,50 @@ void play_song(int index) {
     current_song = index;
     paused_accum = 0.0;
     paused_since = 0;
-    current_duration = get_duration_seconds(playlist[index]);
+    if (known_duration > 0) {
+        current_duration = known_duration;
+        current_fps = known_fps > 0 ? known_fps : DEFAULT_FRAMES_PER_SEC;
+    } else {
+        current_duration = get_duration_seconds(playlist[index], &current_fps);
+    }
+    prefetch_index = -1;
+    if (offset < 0 || (current_duration > 0 && offset >= current_duration)) offset = 0.0;
+    start_offset = offset;
+
+    // mpg123 -k skips whole frames, so convert the offset to a frame count
+    char frames[32];
+    snprintf(frames, sizeof(frames), "%ld", (long)(offset * current_fps));
 
     pid_t pid = fork();
     if (pid < 0) {
         perror("fork");
+        reset_playback_state(); // the old player is gone; do not keep "playing" nothing
         return;
     }
     if (pid == 0) {
         // Child: execlp mpg123; use -q to reduce console noise
-        execlp("mpg123", "mpg123", "-q", playlist[index], NULL);
+        execlp("mpg123", "mpg123", "-q", "-k", frames, playlist[index], NULL);
         perror("execlp mpg123 failed");
         _exit(1);
     } else {
         player_pid = pid;
-        play_start = time(NULL);
+        owns_player = 1;
+        play_start = monotonic_ns();
         state = STATE_PLAYING;
-        fprintf(stderr, "[server] Started mpg123 pid=%d playing '%s' duration=%.2f\n", (int)player_pid, playlist[index], current_duration);
+        fprintf(stderr, "[server] Started mpg123 pid=%d playing '%s' at %.2f duration=%.2f\n", (int)player_pid, playlist[index], start_offset, current_duration);
     }
 }
 
+/* Start playback from the beginning */
+void play_song(int index) {
+    play_song_at(index, 0.0, 0.0, 0.0);
+}
+
 /* Pause/resume/next */
 void pause_song() {
     if (player_pid > 0 && state == STATE_PLAYING) {
         if (kill(player_pid, SIGSTOP) == 0) {
-            paused_since = time(NULL);
+            paused_since = monotonic_ns();
             state = STATE_PAUSED;
             fprintf(stderr, "[server] Paused pid=%d\n", (int)player_pid);
         }
@@ -122,7 +217,7 @@ void resume_song() {
     if (player_pid > 0 && state == STATE_PAUSED) {
         // accumulate paused time
         if (paused_since) {
-            paused_accum += difftime(time(NULL), paused_since);
+            paused_accum += (monotonic_ns() - paused_since) / 1e9;
             paused_since = 0;
         }
         if (kill(player_pid, SIGCONT) == 0) {
@@ -136,27 +231,21 @@ void stop_song() {
     if (player_pid > 0) {
         kill(player_pid, SIGKILL);
         waitpid(player_pid, NULL, 0);
-        player_pid = -1;
     }
-    state = STATE_STOPPED;
-    current_song = -1;
-    paused_since = 0;
-    paused_accum = 0.0;
-    current_duration = 0.0;
+    reset_playback_state();
 }
 
 /* compute elapsed seconds */
 double current_elapsed_seconds() {
     if (state == STATE_STOPPED) return 0.0;
     if (state == STATE_PLAYING) {
-        time_t now = time(NULL);
-        double elapsed = difftime(now, play_start) - paused_accum;
+        double elapsed = start_offset + (monotonic_ns() - play_start) / 1e9 - paused_accum;
         if (elapsed < 0) elapsed = 0;
         return elapsed;
     }
     // paused
     if (state == STATE_PAUSED) {
-        double elapsed = difftime(paused_since, play_start) - paused_accum;
+        double elapsed = start_offset + (paused_since - play_start) / 1e9 - paused_accum;
         if (elapsed < 0) elapsed = 0;
         return elapsed;
     }
@@ -166,8 +255,49 @@ double current_elapsed_seconds() {
 /* next song (wrap) */
 void next_song() {
     if (song_count == 0) return;
-    int next = (current_song + 1) % song_count;
-    play_song(next);
+    play_song(next_index());
+}
+
+/* playback snapshot: "<index> <state> <elapsed> <duration> <frames/s> <path>", written via rename so it is never torn.
+   Only the owner of the player writes it, so a client that never touched playback cannot clobber it. */
+void save_snapshot() {
+    if (!owns_player) return;
+    FILE *fp = fopen(SNAPSHOT_FILE ".tmp", "w");
+    if (!fp) return;
+    if (state != STATE_STOPPED && current_song >= 0 && current_song < song_count) {
+        fprintf(fp, "%d %d %.3f %.3f %.4f %s\n", current_song, (int)state,
+                current_elapsed_seconds(), current_duration, current_fps, playlist[current_song]);
+    }
+    fclose(fp);
+    rename(SNAPSHOT_FILE ".tmp", SNAPSHOT_FILE);
+}
+
+/* Read the snapshot; returns 1 if it describes a playing or paused song still in the playlist */
+int load_snapshot(int *index, int *st, double *elapsed, double *duration, double *fps) {
+    FILE *fp = fopen(SNAPSHOT_FILE, "r");
+    if (!fp) return 0;
+    char path[MAX_LEN];
+    int ok = fscanf(fp, "%d %d %lf %lf %lf %511[^\n]", index, st, elapsed, duration, fps, path) == 6;
+    fclose(fp);
+    if (!ok || *index < 0 || *index >= song_count) return 0;
+    // ignore the snapshot if the playlist changed underneath it
+    if (strcmp(playlist[*index], path) != 0) {
+        fprintf(stderr, "[server] Snapshot song '%s' no longer at index %d, ignoring\n", path, *index);
+        return 0;
+    }
+    return *st == STATE_PLAYING || *st == STATE_PAUSED;
+}
+
+/* Restore the snapshot at startup; returns 1 if playback was resumed */
+int restore_snapshot() {
+    int index, st;
+    double elapsed, duration, fps;
+    if (!load_snapshot(&index, &st, &elapsed, &duration, &fps)) return 0;
+
+    play_song_at(index, elapsed, duration, fps);
+    if (player_pid <= 0) return 0;
+    if (st == STATE_PAUSED) pause_song();
+    return 1;
 }
 
 /* Format MM:SS helper (not used in STATUS; used for logs if needed) */
@@ -178,91 +308,202 @@ void sec_to_mmss(double s, char *out, size_t cap) {
     snprintf(out, cap, "%02d:%02d", mm, ss);
 }
 
+/* select() timeout for a playback loop: 1 s, shorter when the clock fallback is due.
+   The player's exit itself wakes select() via SIGCHLD. */
+void playback_timeout(struct timeval *tv) {
+    tv->tv_sec = 1; tv->tv_usec = 0;
+    if (state == STATE_PLAYING && player_pid > 0 && current_duration > 1.0) {
+        double remaining = current_duration + END_GRACE - current_elapsed_seconds();
+        if (remaining < 0) remaining = 0;
+        if (remaining < 1.0) { tv->tv_sec = 0; tv->tv_usec = (suseconds_t)(remaining * 1e6); }
+    }
+}
+
+/* Per-wakeup playback housekeeping for whichever process owns the player:
+   auto-advance, read-ahead and periodic snapshots */
+void playback_tick(long long *last_snapshot) {
+    // If playback finished, auto advance to next if appropriate
+    double elapsed = current_elapsed_seconds();
+    if (state == STATE_PLAYING && player_pid > 0) {
+        int finished = 0, st;
+        pid_t w = waitpid(player_pid, &st, WNOHANG);
+        if (w == player_pid) {
+            // the player exited on its own: the real end of the track
+            player_pid = -1;
+            if (WIFEXITED(st) && WEXITSTATUS(st) == 0) {
+                fprintf(stderr, "[server] Song finished (player exited at elapsed %.1f)\n", elapsed);
+                finished = 1;
+            } else {
+                fprintf(stderr, "[server] Player failed (status %d), stopping\n", st);
+                stop_song();
+            }
+        } else if (current_duration > 1.0 && elapsed >= current_duration + END_GRACE) {
+            // fallback for a player we cannot wait for (inherited from a restore) or one that hung
+            fprintf(stderr, "[server] Song finished (elapsed %.1f past duration %.1f)\n", elapsed, current_duration);
+            finished = 1;
+        }
+        if (finished) {
+            long long gap_start = monotonic_ns();
+            // kill the child if still there
+            if (player_pid > 0) {
+                kill(player_pid, SIGKILL);
+                waitpid(player_pid, NULL, 0);
+                player_pid = -1;
+            }
+            // automatically advance
+            if (song_count > 0) {
+                int next = next_index();
+                int warm = next == prefetch_index;
+                play_song(next);
+                fprintf(stderr, "[server] Track transition gap %.1f ms (%s)\n", ms_since(gap_start), warm ? "prefetched" : "cold");
+            } else {
+                stop_song();
+            }
+        }
+    }
+
+    // Read ahead the next track shortly before this one ends
+    if (state == STATE_PLAYING && prefetch_index < 0 && current_duration > 0 &&
+        current_duration - current_elapsed_seconds() <= PREFETCH_LEAD) {
+        prefetch_song(next_index());
+    }
+
+    // Periodic snapshot so a crash loses at most SNAPSHOT_INTERVAL seconds
+    if (monotonic_ns() - *last_snapshot >= SNAPSHOT_INTERVAL * 1000000000LL) {
+        save_snapshot();
+        *last_snapshot = monotonic_ns();
+    }
+}
+
+/* Execute one command line; every command answers with exactly one final OK/ERR line.
+   Returns 1 if the client asked to close the connection. */
+int handle_command(int client_fd, char *cmd) {
+    fprintf(stderr, "[server] Received command: '%s'\n", cmd);
+
+    if (strncmp(cmd, "play", 4) == 0) {
+        if (state == STATE_STOPPED) {
+            if (song_count > 0) {
+                play_song(0);
+            } else {
+                const char *msg = "ERR No songs in playlist\n";
+                send(client_fd, msg, strlen(msg), 0);
+                return 0;
+            }
+        } else if (state == STATE_PAUSED) {
+            resume_song();
+        } else {
+            // already playing
+        }
+        const char *ok = "OK Playing\n";
+        send(client_fd, ok, strlen(ok), 0);
+    } else if (strncmp(cmd, "pause", 5) == 0) {
+        pause_song();
+        const char *ok = "OK Paused\n";
+        send(client_fd, ok, strlen(ok), 0);
+    } else if (strncmp(cmd, "next", 4) == 0) {
+        next_song();
+        const char *ok = "OK Next\n";
+        send(client_fd, ok, strlen(ok), 0);
+    } else if (strncmp(cmd, "add ", 4) == 0) {
+        char *song = cmd + 4;
+        if (song_count < MAX_SONGS) {
+            playlist[song_count++] = strdup(song);
+            save_playlist();
+            const char *ok = "OK Song added\n";
+            send(client_fd, ok, strlen(ok), 0);
+        } else {
+            const char *err = "ERR Playlist full\n";
+            send(client_fd, err, strlen(err), 0);
+        }
+    } else if (strncmp(cmd, "list", 4) == 0) {
+        char listbuf[4096] = "";
+        for (int i = 0; i < song_count; ++i) {
+            char line[MAX_LEN];
+            snprintf(line, sizeof(line), "%d. %s\n", i+1, playlist[i]);
+            strncat(listbuf, line, sizeof(listbuf) - strlen(listbuf) - 1);
+        }
+        if (song_count==0) strncpy(listbuf, "No songs.\n", sizeof(listbuf));
+        send(client_fd, listbuf, strlen(listbuf), 0);
+        // trailing OK so pipelined clients know where the listing ends
+        char ok[64];
+        snprintf(ok, sizeof(ok), "OK %d songs\n", song_count);
+        send(client_fd, ok, strlen(ok), 0);
+    } else if (strncmp(cmd, "stop", 4) == 0 || strncmp(cmd, "exit", 4) == 0) {
+        const char *ok = "OK Bye\n";
+        send(client_fd, ok, strlen(ok), 0);
+        return 1;
+    } else {
+        const char *unk = "ERR Unknown command\n";
+        send(client_fd, unk, strlen(unk), 0);
+    }
+    return 0;
+}
+
 /* Client handler: persistent connection that reads commands and sends STATUS lines */
 void handle_client(int client_fd) {
-    char buf[MAX_LEN];
+    char inbuf[MAX_LEN * 4];
+    size_t inlen = 0;
+    int discarding = 0; // dropping the rest of an overlong line until its newline
     ssize_t n;
     // Make socket non-blocking for write operations to avoid blocking the status loop
     int flags = fcntl(client_fd, F_GETFL, 0);
     fcntl(client_fd, F_SETFL, flags & ~O_NONBLOCK); // keep blocking reads for simplicity
+    long long last_snapshot = monotonic_ns();
 
     // We'll use a simple loop: use select with 1s timeout to both check incoming commands and send STATUS every sec
-    while (1) {
+    while (!shutting_down) {
         fd_set readfds;
         struct timeval tv;
         FD_ZERO(&readfds);
         FD_SET(client_fd, &readfds);
         // Also monitor for commands via client socket; client will send newline-terminated commands
-        tv.tv_sec = 1; tv.tv_usec = 0;
+        playback_timeout(&tv);
         int rv = select(client_fd + 1, &readfds, NULL, NULL, &tv);
         if (rv < 0) {
-            if (errno == EINTR) continue;
-            perror("select");
-            break;
+            if (errno != EINTR) {
+                perror("select");
+                break;
+            }
+            if (shutting_down) continue;
+            rv = 0; // SIGCHLD: go check the player
         }
         if (rv > 0 && FD_ISSET(client_fd, &readfds)) {
-            // read a command (up to newline)
-            memset(buf, 0, sizeof(buf));
-            n = recv(client_fd, buf, sizeof(buf)-1, 0);
+            // commands may arrive pipelined, so buffer and split on newlines
+            n = recv(client_fd, inbuf + inlen, sizeof(inbuf) - 1 - inlen, 0);
             if (n <= 0) {
                 // client closed
                 break;
             }
-            // trim newline
-            buf[strcspn(buf, "\r\n")] = 0;
-            fprintf(stderr, "[server] Received command: '%s'\n", buf);
-
-            if (strncmp(buf, "play", 4) == 0) {
-                if (state == STATE_STOPPED) {
-                    if (song_count > 0) {
-                        play_song(0);
-                    } else {
-                        const char *msg = "ERR No songs in playlist\n";
-                        send(client_fd, msg, strlen(msg), 0);
-                    }
-                } else if (state == STATE_PAUSED) {
-                    resume_song();
+            inlen += n;
+            inbuf[inlen] = '\0';
+
+            int quit = 0;
+            char *line = inbuf;
+            char *nl;
+            if (discarding) {
+                nl = strpbrk(line, "\r\n");
+                if (nl) {
+                    discarding = 0;
+                    line = nl + 1;
                 } else {
-                    // already playing
+                    line = inbuf + inlen;
                 }
-                const char *ok = "OK Playing\n";
-                send(client_fd, ok, strlen(ok), 0);
-            } else if (strncmp(buf, "pause", 5) == 0) {
-                pause_song();
-                const char *ok = "OK Paused\n";
-                send(client_fd, ok, strlen(ok), 0);
-            } else if (strncmp(buf, "next", 4) == 0) {
-                next_song();
-                const char *ok = "OK Next\n";
-                send(client_fd, ok, strlen(ok), 0);
-            } else if (strncmp(buf, "add ", 4) == 0) {
-                char *song = buf + 4;
-                if (song_count < MAX_SONGS) {
-                    playlist[song_count++] = strdup(song);
-                    save_playlist();
-                    const char *ok = "OK Song added\n";
-                    send(client_fd, ok, strlen(ok), 0);
-                } else {
-                    const char *err = "ERR Playlist full\n";
-                    send(client_fd, err, strlen(err), 0);
-                }
-            } else if (strncmp(buf, "list", 4) == 0) {
-                char listbuf[4096] = "";
-                for (int i = 0; i < song_count; ++i) {
-                    char line[MAX_LEN];
-                    snprintf(line, sizeof(line), "%d. %s\n", i+1, playlist[i]);
-                    strncat(listbuf, line, sizeof(listbuf) - strlen(listbuf) - 1);
-                }
-                if (song_count==0) strncpy(listbuf, "No songs.\n", sizeof(listbuf));
-                send(client_fd, listbuf, strlen(listbuf), 0);
-            } else if (strncmp(buf, "stop", 4) == 0 || strncmp(buf, "exit", 4) == 0) {
-                const char *ok = "OK Bye\n";
-                send(client_fd, ok, strlen(ok), 0);
-                break;
-            } else {
-                const char *unk = "ERR Unknown command\n";
-                send(client_fd, unk, strlen(unk), 0);
             }
+            while (!quit && (nl = strpbrk(line, "\r\n")) != NULL) {
+                *nl = '\0';
+                if (*line) quit = handle_command(client_fd, line);
+                line = nl + 1;
+            }
+            // a full buffer with no newline is rejected rather than run truncated
+            if (!quit && line == inbuf && inlen == sizeof(inbuf) - 1) {
+                const char *err = "ERR Line too long\n";
+                send(client_fd, err, strlen(err), 0);
+                discarding = 1;
+                line = inbuf + inlen;
+            }
+            inlen -= line - inbuf;
+            memmove(inbuf, line, inlen);
+            if (quit) break;
         }
 
         // Periodic status update (every select timeout)
@@ -271,7 +512,7 @@ void handle_client(int client_fd) {
         const char *stname = (state==STATE_PLAYING) ? "PLAYING" : (state==STATE_PAUSED) ? "PAUSED" : "STOPPED";
 
         // Send STATUS
-        snprintf(status_line, sizeof(status_line), "STATUS %s %.0f %.0f\n", stname, elapsed, current_duration);
+        snprintf(status_line, sizeof(status_line), "STATUS %s %.3f %.3f\n", stname, elapsed, current_duration);
         ssize_t sres = send(client_fd, status_line, strlen(status_line), 0);
 
         // Send CURRENT song info
@@ -282,7 +523,7 @@ void handle_client(int client_fd) {
 
             // Send NEXT song info
             if (song_count > 1) {
-                int next = (current_song + 1) % song_count;
+                int next = next_index();
                 char next_line[256];
                 snprintf(next_line, sizeof(next_line), "NEXT %s\n", playlist[next]);
                 send(client_fd, next_line, strlen(next_line), 0);
@@ -293,39 +534,104 @@ void handle_client(int client_fd) {
             if (errno == EPIPE || errno == ECONNRESET) break;
         }
 
-        // If playback finished, auto advance to next if appropriate
-        if (state == STATE_PLAYING && current_duration > 1.0) {
-            if (elapsed >= current_duration - 0.5) { // a little tolerance
-                // song finished
-                fprintf(stderr, "[server] Song finished (elapsed %.1f >= duration %.1f)\n", elapsed, current_duration);
-                // kill the child if still there
-                if (player_pid > 0) {
-                    kill(player_pid, SIGKILL);
-                    waitpid(player_pid, NULL, 0);
-                    player_pid = -1;
-                }
-                // automatically advance
-                if (song_count > 0) {
-                    int next = (current_song + 1) % song_count;
-                    play_song(next);
-                } else {
-                    stop_song();
-                }
-            }
-        }
+        playback_tick(&last_snapshot);
     } // end while
 
+    save_snapshot();
+    if (shutting_down) stop_song();
     close(client_fd);
     fprintf(stderr, "[server] Client disconnected\n");
 }
 
+/* Client handler processes forked by the accept loop */
+pid_t client_pids[MAX_CLIENTS];
+int client_count = 0;
+
+/* Player restored at startup and handed to the first client; reaped only after that client
+   exits, so its pid stays reserved (as a zombie at worst) while the client may still signal it */
+pid_t handed_off_player = -1;
+pid_t handoff_client = -1;
+
+/* Take back a handed-off player that outlived its client, using the position that
+   client saved on disconnect, so the next client can control it again */
+void reclaim_player(pid_t pid) {
+    int index, st;
+    double elapsed, duration, fps;
+    if (!load_snapshot(&index, &st, &elapsed, &duration, &fps)) {
+        // no usable position: better silent than an uncontrollable player
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+        return;
+    }
+    reset_playback_state();
+    player_pid = pid;
+    owns_player = 1;
+    current_song = index;
+    current_duration = duration;
+    current_fps = fps;
+    start_offset = elapsed;
+    play_start = monotonic_ns();
+    state = st == STATE_PAUSED ? STATE_PAUSED : STATE_PLAYING;
+    if (state == STATE_PAUSED) paused_since = play_start;
+    fprintf(stderr, "[server] Took back player pid=%d at %.2f\n", (int)pid, elapsed);
+}
+
+/* Reap finished client handlers; the handed-off player is reaped, or taken back if still
+   running, once its client is gone */
+void reap_clients() {
+    for (int i = 0; i < client_count; ) {
+        if (waitpid(client_pids[i], NULL, WNOHANG) > 0) {
+            if (client_pids[i] == handoff_client) handoff_client = -1;
+            client_pids[i] = client_pids[--client_count];
+        } else {
+            i++;
+        }
+    }
+    if (handed_off_player > 0 && handoff_client < 0) {
+        if (waitpid(handed_off_player, NULL, WNOHANG) == 0) reclaim_player(handed_off_player);
+        handed_off_player = -1;
+    }
+}
+
 int main() {
     int sockfd, newsock;
     struct sockaddr_in server_addr, client_addr;
     socklen_t client_len = sizeof(client_addr);
 
+    long long boot_start = monotonic_ns();
+
     load_playlist();
 
+    // No SA_RESTART: select()/accept() must return EINTR so loops can save and exit
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_shutdown_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    // SA_RESTART keeps accept()/popen reads going; select() still returns EINTR so
+    // client loops notice the player exiting right away
+    struct sigaction sc;
+    memset(&sc, 0, sizeof(sc));
+    sc.sa_handler = on_child_exit;
+    sc.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sigemptyset(&sc.sa_mask);
+    sigaction(SIGCHLD, &sc, NULL);
+
+    // A client that hangs up must not kill its handler before it saves the snapshot;
+    // send() then fails with EPIPE and the loop exits normally
+    signal(SIGPIPE, SIG_IGN);
+
+    // Resume where the previous run left off, without re-probing the file
+    if (restore_snapshot()) {
+        // covers playlist load and the fork; mpg123 exec, seek and audio output come after
+        double spawn_ms = ms_since(boot_start);
+        fprintf(stderr, "[server] Restored '%s' at %.2fs, player spawned %.1f ms after startup%s\n",
+                playlist[current_song], start_offset, spawn_ms,
+                spawn_ms > SPAWN_TARGET_MS ? " (over target)" : "");
+    }
+
     sockfd = socket(AF_INET, SOCK_STREAM, 0);
     if (sockfd < 0) { perror("socket"); exit(1); }
 
@@ -348,7 +654,24 @@ int main() {
 
     fprintf(stderr, "🎵 Music Player Daemon running on port %d...\n", PORT);
 
-    while (1) {
+    // Between connections the daemon itself drives a restored or taken-back player
+    long long last_snapshot = monotonic_ns();
+    while (!shutting_down) {
+        fd_set readfds;
+        struct timeval tv;
+        FD_ZERO(&readfds);
+        FD_SET(sockfd, &readfds);
+        playback_timeout(&tv);
+        int rv = select(sockfd + 1, &readfds, NULL, NULL, &tv);
+        if (rv < 0 && errno != EINTR) {
+            perror("select");
+            continue;
+        }
+
+        reap_clients();
+        playback_tick(&last_snapshot);
+        if (rv <= 0 || !FD_ISSET(sockfd, &readfds)) continue;
+
         newsock = accept(sockfd, (struct sockaddr *)&client_addr, &client_len);
         if (newsock < 0) {
             if (errno == EINTR) continue;
@@ -356,6 +679,13 @@ int main() {
             continue;
         }
 
+        if (client_count == MAX_CLIENTS) {
+            const char *err = "ERR Too many clients\n";
+            send(newsock, err, strlen(err), 0);
+            close(newsock);
+            continue;
+        }
+
         pid_t pid = fork();
         if (pid < 0) {
             perror("fork");
@@ -370,11 +700,33 @@ int main() {
         } else {
             // parent closes client socket and continues
             close(newsock);
-            // optionally reap children
-            while (waitpid(-1, NULL, WNOHANG) > 0) {}
+            client_pids[client_count++] = pid;
+            // the player now belongs to this child until it exits; later clients must not inherit it
+            if (owns_player) {
+                handed_off_player = player_pid;
+                handoff_client = pid;
+                reset_playback_state();
+                owns_player = 0;
+            }
         }
     }
 
+    // Set if the daemon holds the player, i.e. no client currently has it
+    if (owns_player) {
+        save_snapshot();
+        stop_song();
+    }
+    // A plain `kill <pid>` only reaches this process: pass it on so each client
+    // handler saves its snapshot and stops its player, then wait for them
+    for (int i = 0; i < client_count; ++i) {
+        kill(client_pids[i], SIGTERM);
+        waitpid(client_pids[i], NULL, 0);
+    }
+    if (handed_off_player > 0) {
+        kill(handed_off_player, SIGKILL);
+        waitpid(handed_off_player, NULL, 0);
+    }
     close(sockfd);
+    fprintf(stderr, "[server] Shutting down\n");
     return 0;
 }
\ No newline at end of file